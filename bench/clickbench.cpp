@@ -0,0 +1,317 @@
+/*
+  Benchmark of the auto-click engine, for Linux or any other system with a C++11 compiler.
+  Replays pointer traces through autoClick() on a virtual clock, and timestamps the button-downs it injects.
+
+  Build and run from the repository root:
+    g++ -O2 -o clickbench bench/clickbench.cpp
+    ./clickbench [-save] [trace files]
+
+  Without trace files it replays a built-in synthetic trace, which is the same on every run.
+  A trace file has one pointer sample per line: "milliseconds x y". Lines starting with # are comments.
+
+  Reports the time per engine tick of the fixed configuration that launch picks for the default settings,
+  against the generic engine that reads every setting at runtime.
+  Both must inject the same clicks at the same times, or the benchmark fails.
+
+  Then, for each way that WM_TIMER may be scheduled, reports the latency from the pointer stopping to the button-down,
+  as p50, p99 and p999, and the processor time per click.
+  The latency includes the UPDATESPEED tick, the CLICKTIME countdown and the 50 millisecond waits after sending input.
+  It fails when a percentile is more than 10% worse than in bench/baseline.txt. "-save" writes that file instead.
+  Processor time depends on the machine, so it is only reported.
+*/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include "../src/clickengine.h"
+
+
+const char *BASELINEFILE = "bench/baseline.txt";
+const double TOLERANCE = 1.1;         // allowed ratio over baseline latency before it counts as a regression.
+
+// Ways that WM_TIMER can come, as far as timing goes:
+struct Schedule {
+  const char *name;
+  double period;                      // system timer period in milliseconds, that timers fire on. 0 fires exactly on time.
+};
+const Schedule SCHEDULES[] = {
+  {"exact", 0},                       // an ideal timer.
+  {"period-1ms", 1},                  // with timeBeginPeriod(1) in effect, e.g. by another program.
+  {"period-15.6ms", 15.625},          // the default Windows timer period.
+};
+
+
+struct Sample {
+  double time;                        // milliseconds since the start of the trace.
+  Point mouse;
+};
+typedef std::vector<Sample> Trace;
+
+
+// Io that moves the cursor along a trace, and timestamps the clicks instead of sending them.
+struct TraceIo {
+  const Trace *trace = NULL;
+  size_t next = 0;                    // index of the first sample that lies ahead of the virtual clock.
+  double clock = 0;                   // virtual time in milliseconds.
+  Point moved = {};                   // where setCursor() moved the cursor, until the trace moves it again.
+  double movedtime = -1;
+  bool held = false;                  // whether an injected button press is still down.
+  std::vector<double> downs;          // times of injected button-downs.
+
+  void start(const Trace &t) {
+    trace = &t;  next = 0;  clock = t.front().time;  movedtime = -1;  held = false;  downs.clear();
+  }
+  // Advances the virtual clock, as the Windows API calls that wait do.
+  void wait(double ms) {clock += ms;}
+
+  bool buttonHeld() {return held;}
+  bool shiftHeld()  {return false;}
+  bool escapeHeld() {return false;}
+  Point cursor() {
+    while(next < trace->size() && (*trace)[next].time <= clock) {next++;}
+    const Sample &sample = (*trace)[(next)? next - 1 : 0];
+    return (movedtime > sample.time)? moved : sample.mouse;
+  }
+  void setCursor(Point p) {moved = p;  movedtime = clock;}
+  // A maximized window on a 1920x1080 screen.
+  Rect foregroundFrame() {return Rect{0, 0, 1920, 1040};}
+  Rect screenAt(Point) {return Rect{0, 0, 1920, 1080};}
+  bool subScrollbar(Point, Rect &) {return false;}
+  double now() {return clock;}
+  double doubleClickTime() {return 500;}
+  Point doubleClickSize() {return Point{4, 4};}
+  void sendMouse(const MouseEvent *events, int count) {
+    for(int i = 0; i < count; i++) {
+      if(events[i] == LEFT_DOWN || events[i] == RIGHT_DOWN) {downs.push_back(clock);  held = true;}
+      else {held = false;}
+    }
+    // sendMouse() in autoclick.cpp gives programs 50 milliseconds to process the clicks.
+    wait(50);
+  }
+  void pressShift(bool) {wait(50);}
+  void beep() {}
+  void record(unsigned char, Point, Rect) {}
+};
+
+
+// Runs the engine over the whole trace.
+// WM_TIMER ticks are due every UPDATESPEED milliseconds, or straight after a tick that took longer,
+// and then come at the next tick of the system timer.
+void replay(AutoClickFunction<TraceIo> engine, const Trace &trace, TraceIo &io, long &ticks, double period = 0) {
+ClickState state;
+const Settings settings;
+io.start(trace);
+ticks = 0;
+double due = io.clock;
+while(io.clock < trace.back().time) {
+  if(io.clock < due) {io.clock = due;}
+  if(period) {io.clock = ceil(io.clock / period) * period;}
+  const double tick = io.clock;
+  engine(state, settings, io);
+  ticks++;
+  due = tick + UPDATESPEED;
+}
+}
+
+
+// Nanoseconds per tick, the best of several runs to leave out scheduling noise.
+double tickCost(AutoClickFunction<TraceIo> engine, const Trace &trace, TraceIo &io) {
+const int RUNS = 50;
+double best = 0;
+for(int r = 0; r < RUNS; r++) {
+  long ticks = 0;
+  auto begin = std::chrono::steady_clock::now();
+  replay(engine, trace, io, ticks);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - begin).count() / ticks;
+  if(!r || ns < best) {best = ns;}
+}
+return best;
+}
+
+
+// Builds a trace of a user pointing at things: moves in all directions at varying speeds, with pauses in between.
+// Uses its own random number generator so that the trace is the same everywhere.
+Trace syntheticTrace() {
+const double SAMPLETIME = 8;          // a 125 Hz mouse.
+const int MOVES = 2000;
+unsigned int seed = 12345;
+auto random = [&seed](int range) {seed = seed * 1103515245 + 12345;  return int((seed >> 16) % range);};
+Trace trace;
+double time = 0;
+Point mouse = {960, 520};
+trace.push_back(Sample{time, mouse});
+for(int m = 0; m < MOVES; m++) {
+  // Move to a random target,
+  Point target = {100 + random(1700), 100 + random(900)};
+  int steps = 5 + random(60);
+  Point from = mouse;
+  for(int s = 1; s <= steps; s++) {
+    time += SAMPLETIME;
+    mouse = Point{from.x + (target.x - from.x) * s / steps, from.y + (target.y - from.y) * s / steps};
+    trace.push_back(Sample{time, mouse});
+  }
+  // then rest there, sometimes briefly, with a pixel of jitter now and then.
+  int rest = random(4) ? 100 + random(1400) : random(100);
+  for(int s = 0; s < rest / SAMPLETIME; s++) {
+    time += SAMPLETIME;
+    if(!random(40)) {mouse.x += random(3) - 1;}
+    trace.push_back(Sample{time, mouse});
+  }
+}
+return trace;
+}
+
+
+// Reads a trace file. Returns false if it can't be read or holds no samples.
+bool loadTrace(const char *filename, Trace &trace) {
+FILE *file = fopen(filename, "r");
+if(!file) {return false;}
+char line[256];
+while(fgets(line, sizeof(line), file)) {
+  Sample sample = {};
+  if(line[0] != '#' && sscanf(line, "%lf %ld %ld", &sample.time, &sample.mouse.x, &sample.mouse.y) == 3) {
+    trace.push_back(sample);
+  }
+}
+fclose(file);
+return !trace.empty();
+}
+
+
+// Stop-to-click latencies of the clicks in 'io', in milliseconds.
+// The pointer stops at the last sample that moved more than a pixel. Only the first click after each stop counts.
+// Stops after moving down-right are left out: those park the mouse, and a click there only comes from later jitter.
+std::vector<double> latencies(const Trace &trace, const TraceIo &io) {
+std::vector<double> result;
+size_t s = 0;
+double stop = -1;                     // time of the last movement before the current click.
+bool parked = false;                  // whether that movement went down-right.
+double counted = -1;                  // stop that already has its click.
+for(double down : io.downs) {
+  for(; s < trace.size() && trace[s].time <= down; s++) {
+    if(!s) {continue;}
+    long dx = trace[s].mouse.x - trace[s-1].mouse.x, dy = trace[s].mouse.y - trace[s-1].mouse.y;
+    if(labs(dx) > 1 || labs(dy) > 1) {stop = trace[s].time;  parked = dx >= 0 && dy > 0;}
+  }
+  if(stop >= 0 && stop != counted && !parked) {result.push_back(down - stop);}
+  counted = stop;
+}
+std::sort(result.begin(), result.end());
+return result;
+}
+
+// Nearest-rank percentile of sorted values.
+double percentile(const std::vector<double> &sorted, double p) {
+if(sorted.empty()) {return 0;}
+size_t rank = (size_t)ceil(p / 100 * sorted.size());
+return sorted[(rank)? rank - 1 : 0];
+}
+
+
+// One line of results, as stored in the baseline file.
+struct Result {
+  char trace[200];
+  char schedule[32];
+  double p50, p99, p999;
+};
+std::vector<Result> baseline;
+
+void loadBaseline() {
+FILE *file = fopen(BASELINEFILE, "r");
+if(!file) {return;}
+char line[512];
+while(fgets(line, sizeof(line), file)) {
+  Result result = {};
+  if(line[0] != '#' && sscanf(line, "%199s %31s p50 %lf p99 %lf p999 %lf", result.trace, result.schedule, &result.p50, &result.p99, &result.p999) == 5) {
+    baseline.push_back(result);
+  }
+}
+fclose(file);
+}
+
+// Compares with the baseline. Returns false if latency regressed.
+bool compareBaseline(const Result &result) {
+for(const Result &base : baseline) {
+  if(strcmp(base.trace, result.trace) || strcmp(base.schedule, result.schedule)) {continue;}
+  bool regressed = result.p50 > base.p50 * TOLERANCE || result.p99 > base.p99 * TOLERANCE || result.p999 > base.p999 * TOLERANCE;
+  if(regressed) {
+    printf("  FAILED: %s latency got worse than the baseline (p50 %.1f, p99 %.1f, p999 %.1f ms)\n", result.schedule, base.p50, base.p99, base.p999);
+  }
+  return !regressed;
+}
+printf("  %s: not in the baseline\n", result.schedule);
+return true;
+}
+
+
+// Benchmarks one trace. Returns false if the engines disagree or latency regressed.
+// Adds the latency results to 'results'.
+bool benchTrace(const char *name, const Trace &trace, std::vector<Result> &results) {
+const Settings defaults;
+AutoClickFunction<TraceIo> fixed = pickAutoClick<TraceIo>(defaults);
+AutoClickFunction<TraceIo> generic = autoClick<GenericConfig, TraceIo>;
+TraceIo fixedio, genericio;
+long ticks = 0;
+replay(fixed, trace, fixedio, ticks);
+replay(generic, trace, genericio, ticks);
+printf("%s: %.0f seconds, %ld ticks, %d clicks\n", name, (trace.back().time - trace.front().time) / 1000, ticks, int(fixedio.downs.size()));
+if(fixedio.downs != genericio.downs) {
+  printf("  FAILED: the fixed and generic engines clicked differently (%d against %d clicks)\n", int(fixedio.downs.size()), int(genericio.downs.size()));
+  return false;
+}
+double fixedcost = tickCost(fixed, trace, fixedio);
+double genericcost = tickCost(generic, trace, genericio);
+printf("  per tick: fixed %.1f ns, generic %.1f ns (%+.1f%%)\n", fixedcost, genericcost, 100 * (genericcost - fixedcost) / fixedcost);
+
+bool ok = true;
+for(const Schedule &schedule : SCHEDULES) {
+  // Processor time over several runs, as one run is about as short as clock() can measure.
+  const int RUNS = 20;
+  clock_t begin = clock();
+  for(int r = 0; r < RUNS; r++) {replay(fixed, trace, fixedio, ticks, schedule.period);}
+  double cpu = double(clock() - begin) / CLOCKS_PER_SEC / RUNS;
+  std::vector<double> sorted = latencies(trace, fixedio);
+  Result result = {};
+  snprintf(result.trace, sizeof(result.trace), "%s", name);
+  snprintf(result.schedule, sizeof(result.schedule), "%s", schedule.name);
+  result.p50 = percentile(sorted, 50);
+  result.p99 = percentile(sorted, 99);
+  result.p999 = percentile(sorted, 99.9);
+  printf("  %-14s p50 %.1f ms, p99 %.1f ms, p999 %.1f ms, CPU %.2f us per click\n", schedule.name, result.p50, result.p99, result.p999,
+         (fixedio.downs.empty())? 0 : cpu * 1e6 / fixedio.downs.size());
+  results.push_back(result);
+  ok = compareBaseline(result) && ok;
+}
+return ok;
+}
+
+
+int main(int argc, char *argv[]) {
+bool save = argc > 1 && !strcmp(argv[1], "-save");
+int first = (save)? 2 : 1;
+bool ok = true;
+std::vector<Result> results;
+if(!save) {loadBaseline();}
+if(argc <= first) {ok = benchTrace("synthetic", syntheticTrace(), results);}
+for(int a = first; a < argc; a++) {
+  Trace trace;
+  if(!loadTrace(argv[a], trace)) {printf("%s: can't read trace\n", argv[a]);  ok = false;  continue;}
+  ok = benchTrace(argv[a], trace, results) && ok;
+}
+
+if(save && ok) {
+  FILE *file = fopen(BASELINEFILE, "w");
+  if(!file) {printf("can't write %s\n", BASELINEFILE);  return 1;}
+  fprintf(file, "# Stop-to-click latency in milliseconds, written by clickbench -save.\n");
+  for(const Result &result : results) {
+    fprintf(file, "%s %s p50 %.1f p99 %.1f p999 %.1f\n", result.trace, result.schedule, result.p50, result.p99, result.p999);
+  }
+  fclose(file);
+  printf("saved %s\n", BASELINEFILE);
+}
+return (ok)? 0 : 1;
+}
@@ -0,0 +1,188 @@
+/*
+  Check of macro replay timing, for Linux or any other system with a C++11 compiler.
+  Replays macros through replaySteps() against a fake clock that sleeps like Windows does,
+  and a sink that timestamps the clicks instead of sending them.
+
+  Build and run from the repository root:
+    g++ -O2 -o replaybench bench/replaybench.cpp
+    ./replaybench
+
+  Fails when a click comes later than MAXLATENESS after its deadline with a 1 millisecond timer period,
+  or when replay puts clicks in the wrong place, doesn't stop for the user, or leaves a button down.
+  Also reports how late clicks would be without timeBeginPeriod(1), and on this system's real clock.
+*/
+
+#include <stdio.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include "../src/clickengine.h"
+
+
+const double MAXLATENESS = 1;         // milliseconds.
+
+struct Click {
+  double time;                        // when the events were sent, in milliseconds.
+  Point mouse;
+  MouseEvent first;
+  int count;
+};
+
+
+// Macro steps from memory.
+struct StepList {
+  std::vector<MacroStep> steps;
+  size_t next = 0;
+  bool read(MacroStep &step) {
+    if(next >= steps.size()) {return false;}
+    step = steps[next++];
+    return true;
+  }
+};
+
+
+// Io with a fake clock. Sleeping wakes up at the next tick of the system timer, as Sleep() does on Windows.
+struct FakeIo {
+  double clock = 0;                   // virtual time in milliseconds.
+  double period = 1;                  // system timer period: 1 with timeBeginPeriod(1), 15.625 by default.
+  double yield = 0.02;                // time that Sleep(0) takes when nothing else runs.
+  Point mouse = {500, 500};
+  Rect frame = {200, 100, 1200, 900}; // the foreground window.
+  double usermoves = -1;              // time at which the user moves the mouse, if they do.
+  double escape = -1;                 // time at which the user holds escape, if they do.
+  bool held = false;
+  std::vector<Click> clicks;
+
+  double now() {return clock;}
+  void sleep(int ms) {
+    if(!ms) {clock += yield;  return;}
+    double wake = clock + ms;
+    clock = (long long)(wake / period) * period;
+    if(clock < wake) {clock += period;}
+  }
+  Point cursor() {
+    if(usermoves >= 0 && clock >= usermoves) {mouse = Point{mouse.x + 5, mouse.y};  usermoves = -1;}
+    return mouse;
+  }
+  void setCursor(Point p) {mouse = p;}
+  bool escapeHeld() {return escape >= 0 && clock >= escape;}
+  Rect foregroundFrame() {return frame;}
+  void sendMouse(const MouseEvent *events, int count) {
+    clicks.push_back(Click{clock, mouse, events[0], count});
+    held = events[count - 1] == LEFT_DOWN || events[count - 1] == RIGHT_DOWN;
+    // sendMouse() in autoclick.cpp gives programs 50 milliseconds to process the clicks.
+    clock += 50;
+  }
+};
+
+
+// Io on this system's clock, to see how close a desktop scheduler gets to the deadlines.
+struct RealIo {
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Point mouse = {500, 500};
+  std::vector<Click> clicks;
+
+  double now() {return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();}
+  void sleep(int ms) {
+    if(ms) {std::this_thread::sleep_for(std::chrono::milliseconds(ms));}
+    else   {std::this_thread::yield();}
+  }
+  Point cursor() {return mouse;}
+  void setCursor(Point p) {mouse = p;}
+  bool escapeHeld() {return false;}
+  Rect foregroundFrame() {return Rect{0, 0, 1920, 1040};}
+  void sendMouse(const MouseEvent *events, int count) {
+    clicks.push_back(Click{now(), mouse, events[0], count});
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  }
+};
+
+
+// A macro of clicks, double-clicks, right-clicks and drags, 'steps' long, on irregular intervals.
+StepList testMacro(int steps) {
+StepList macro;
+unsigned int time = 0;
+const unsigned char ACTIONS[] = {MACRO_CLICK, MACRO_CLICK, MACRO_DOUBLECLICK, MACRO_OTHERCLICK, MACRO_DOWN, MACRO_UP};
+for(int s = 0; s < steps; s++) {
+  time += 120 + (s * 37) % 700;
+  macro.steps.push_back(MacroStep{time, short(10 + (s * 53) % 900), short(10 + (s * 29) % 700), ACTIONS[s % 6]});
+}
+return macro;
+}
+
+
+// Largest delay between a step's deadline and its click.
+template<class Io> double maxLateness(const StepList &macro, const Io &io, double start, double speed) {
+double worst = 0;
+for(size_t c = 0; c < io.clicks.size(); c++) {
+  double late = io.clicks[c].time - (start + macro.steps[c].time / speed);
+  if(late > worst) {worst = late;}
+}
+return worst;
+}
+
+
+bool check(bool ok, const char *what) {
+if(!ok) {printf("FAILED: %s\n", what);}
+return ok;
+}
+
+
+int main() {
+bool ok = true;
+
+// Timing, with and without timeBeginPeriod(1):
+for(double speed : {1.0, 2.0}) {
+  for(double period : {1.0, 15.625}) {
+    StepList macro = testMacro(200);
+    FakeIo io;
+    io.period = period;
+    io.clock = 3.3;                   // not on a timer tick.
+    bool finished = replaySteps(macro, speed, false, io);
+    double late = maxLateness(macro, io, 3.3, speed);
+    printf("speed %g, timer period %g ms: %d clicks, at most %.2f ms late\n", speed, period, int(io.clicks.size()), late);
+    ok = check(finished && io.clicks.size() == macro.steps.size(), "replay didn't play every step") && ok;
+    if(period == 1) {ok = check(late <= MAXLATENESS, "clicks came too late") && ok;}
+  }
+}
+
+// Positions are relative to the foreground window, and the button mapping follows the settings:
+{
+  StepList macro = testMacro(6);
+  FakeIo io;
+  replaySteps(macro, 1, true, io);
+  bool placed = true;
+  for(size_t c = 0; c < io.clicks.size(); c++) {
+    placed = placed && io.clicks[c].mouse.x == io.frame.left + macro.steps[c].x && io.clicks[c].mouse.y == io.frame.top + macro.steps[c].y;
+  }
+  ok = check(placed, "clicks not placed relative to the foreground window") && ok;
+  ok = check(io.clicks[0].first == RIGHT_DOWN && io.clicks[0].count == 2, "left-handed click didn't use the right button") && ok;
+  ok = check(io.clicks[2].count == 4, "double-click not sent as one batch") && ok;
+  ok = check(io.clicks[3].first == LEFT_DOWN, "left-handed right-click didn't use the left button") && ok;
+}
+
+// Moving the mouse or holding escape stops the replay, and lets go of a drag:
+for(int user = 0; user < 2; user++) {
+  StepList macro = testMacro(12);
+  FakeIo io;
+  // Stop halfway the drag between steps 5 and 6.
+  double stop = macro.steps[4].time + 60;
+  if(user == 0) {io.usermoves = stop;}
+  else          {io.escape = stop;}
+  bool finished = replaySteps(macro, 1, false, io);
+  ok = check(!finished && io.clicks.size() == 6, (user == 0)? "moving the mouse didn't stop the replay" : "escape didn't stop the replay") && ok;
+  ok = check(!io.held, "replay left the mouse button down") && ok;
+}
+
+// The real clock, for information only, as a shared machine may be busy with something else:
+{
+  StepList macro = testMacro(10);
+  RealIo io;
+  double start = io.now();
+  replaySteps(macro, 1, false, io);
+  printf("real clock: %d clicks, at most %.2f ms late\n", int(io.clicks.size()), maxLateness(macro, io, start, 1));
+}
+
+printf((ok)? "replay check passed\n" : "replay check FAILED\n");
+return (ok)? 0 : 1;
+}
@@ -1,10 +1,12 @@
 /*
-  function autoClick() handles the auto-clicking and auto-scrolling.
+  function autoClick() in clickengine.h handles the auto-clicking and auto-scrolling.
+  function recordMacro() and playMacro() handle recording and replaying auto-clicks.
   function remindToPause() handles work break reminders.
   function WindowProcedure() handles the timers.
 */
 
 #include <stdio.h>                    
+#include <stdlib.h>                   // for atof().
 #include <math.h>
 #include <time.h>
 #include <sys/stat.h>                 // for getting file info.
@@ -12,238 +14,128 @@
 #define WINVER 0x0500                 // required to use SendInput() to simulate mouse presses. define before windows.
 #include <windows.h>
 #include <shellapi.h>                 // for system tray icon.
+#include <mmsystem.h>                 // for timeBeginPeriod(). link with -lwinmm.
 
+#include "clickengine.h"              // auto-click engine.
 #include "autoclick.h"                // function declarations.
 
 
 // Settings:
-const int UPDATESPEED = 50;           // Interval at which to update the mouse coordinates and speed. in milliseconds.
 const int MINUTE = 60;                // Just a number to convert minutes to seconds. const is preferred over #define.
 int mainkey = VK_F10;                 // Main program control key, on/off toggle etc.
 int win_key = 0;                      // Key number of windows + key combination if the program is started that way.
-bool lefthanded = false;              // Set through command line parameter to auto-click right button when mouse is configured for left hand.
+Settings settings;                    // Auto-click settings, set through command line parameters.
+
+// Click macros:
+const char *MACROFILE = "autoclick.mac";   // File that macros are recorded to, relative to the working directory like the icons.
+double macrospeed = 1;                // Macro replay speed multiplier. Set through command line parameter, e.g. "speed=2".
+FILE *macrofile = NULL;               // Open while recording a macro.
+double macrostart = 0;                // Time that the recording started, in milliseconds.
+volatile LONG replaying = 0;          // Set while a macro replays on its own thread. Auto-clicking pauses meanwhile.
 
 // User activity tracking:
-bool activity = true;                 // Turned on when user clicks or types.
-bool physicalclick = true;            // Set true if physical mouse button is pressed. 
-                                      // Also set true at launch, as the user probably clicked to launch the program.
-int moving = 0;                       // Speed of mouse in pixels per 50 milliseconds (i.e. per UPDATESPEED).
+ClickState clickstate;                // Auto-click engine state, including mouse activity. See clickengine.h.
 int fullpausetime = 0;                // Length of entire work pause in seconds.
 int workedtime = 0;                   // The time that the user has been working without pausing, in minutes.
 int totalworked = 0;                  // Count how long user has worked all day, in minutes.
-int totalclicks = 0;                  // Count how many times a day user does mouseclicks.
 
 
 
 
-void autoClick(HWND hwnd) {
-/*
-  Tracks mouse movement, speed, and scrollbar mouseover,
-  simulates a mouse click when mouse stops moving.
-*/
-
-// Configuration:
-const int SCROLLBARTOP = 60;          // pixels from top of window to top of scrollbar.
-const int SCROLLBARWIDTH = 27;        // standard scrollbar width in pixels.
-const int SCROLLBARRANGE = 100;       // distance between scrollbar and mouse x-coordinate beyond which the scrollbar is released.
-const int CLICKTIME = 200;            // delay between stop moving and auto-click, in milliseconds.
-const int MENUCLICKTIME = 500;        // delay between stop moving and auto-click when over window close buttons or menu bars.
-const int TIMEBETWEENCLICKS = 350;    // minimum time between two autoclicks, in milliseconds.
-const int leeway = 1;                 // ignorable accidental movement of mouse, in pixels. 
-                                      // e.g. when removing hand from mouse, or wonky mouse.
-
-// Variables for autoclicking:
-POINT mouse = {};                     // a struct with long ints .x and .y to contain the mouse coordinates
-static POINT prevmouse = {};          // previous mouse position, for calculating mouse speed.
-static POINT prevclick = {};          // coordinates of last auto-click, for auto-selecting text.
-static int clicktimer = 0;            // timer in microseconds. can be interrupted with further movement or right-click.
-static int justclicked = 0;           // timer in microseconds that temporarily blocks consequtive auto-clicks.
-static int parking = 0;               // set when mouse is "parked"
-static int dragging = 0;              // represents shift-click-drag
-static int scrolling = 0;
-
-// DETECT PHYSICAL CLICKS:
-// If the user is actually physically clicking a mouse button,
-// don't auto-click until they've released, and moved the mouse elsewhere.
-// Prevent and/or cancel any auto-click when mouse buttons are pressed down:
-if(keyPressed(VK_LBUTTON) || keyPressed(VK_RBUTTON)) {
-  if(!physicalclick && !justclicked && !dragging && !scrolling) {   
-    physicalclick = true;
-    clicktimer = 0;
+// Input and output of the auto-click engine, through the Windows API:
+struct WinIo {
+  bool buttonHeld() {return keyPressed(VK_LBUTTON) || keyPressed(VK_RBUTTON);}
+  bool shiftHeld()  {return keyPressed(VK_SHIFT);}
+  bool escapeHeld() {return keyPressed(VK_ESCAPE);}
+  Point cursor() {POINT mouse = {};  GetCursorPos(&mouse);  return Point{mouse.x, mouse.y};}
+  void setCursor(Point p) {SetCursorPos(p.x, p.y);}
+  Rect foregroundFrame() {
+    RECT windowframe = {};
+    GetWindowRect(GetForegroundWindow(), &windowframe);
+    return Rect{windowframe.left, windowframe.top, windowframe.right, windowframe.bottom};
   }
-  activity = true;
-}
-// On mouse release, restart at current coordinates.
-else if(physicalclick) {
-  totalclicks += 1;
-  physicalclick = false;
-  moving = 0;
-  // Set prevmouse position as if it was current position.
-  GetCursorPos(&prevmouse);
-}
+  Rect screenAt(Point p) {
+    POINT mouse = {p.x, p.y};
+    MONITORINFO monitor = {sizeof(MONITORINFO)};
+    GetMonitorInfo(MonitorFromPoint(mouse, MONITOR_DEFAULTTONEAREST), &monitor);
+    return Rect{monitor.rcMonitor.left, monitor.rcMonitor.top, monitor.rcMonitor.right, monitor.rcMonitor.bottom};
+  }
+  bool subScrollbar(Point p, Rect &area) {
+    POINT mouse = {p.x, p.y};
+    SCROLLBARINFO subscrollbar = {sizeof(SCROLLBARINFO)};   
+    GetScrollBarInfo(WindowFromPoint(mouse), OBJID_VSCROLL, &subscrollbar);   
+    if(!PtInRect(&subscrollbar.rcScrollBar, mouse)) {return false;}
+    area = Rect{subscrollbar.rcScrollBar.left, subscrollbar.rcScrollBar.top, subscrollbar.rcScrollBar.right, subscrollbar.rcScrollBar.bottom};
+    return true;
+  }
+  double now() {return clockMs();}
+  void sleep(int ms) {Sleep(ms);}
+  double doubleClickTime() {return GetDoubleClickTime();}
+  Point doubleClickSize() {return Point{GetSystemMetrics(SM_CXDOUBLECLK), GetSystemMetrics(SM_CYDOUBLECLK)};}
+  void sendMouse(const MouseEvent *events, int count) {
+    const DWORD EVENTFLAGS[4] = {MOUSEEVENTF_LEFTDOWN, MOUSEEVENTF_LEFTUP, MOUSEEVENTF_RIGHTDOWN, MOUSEEVENTF_RIGHTUP};
+    DWORD flags[4] = {};
+    for(int i = 0; i < count && i < 4; i++) {flags[i] = EVENTFLAGS[events[i]];}
+    ::sendMouse(flags, count);
+  }
+  void pressShift(bool down) {pressKey(VK_SHIFT, down);}
+  void beep() {MessageBeep(MB_OK);}
+  void record(unsigned char action, Point p, Rect frame) {recordMacro(action, p, frame);}
+};
+WinIo winio;
 
-// DETECT MOVEMENT AND SPEED:
-// Get current mouse screen coordinates,
-GetCursorPos(&mouse);
-
-// then compare them with previous recorded mouse coordinates to calculate current mouse speed 
-// (speed value is equal to pixels distance between previous x,y and current x,y)
-double speed = sqrt( pow(mouse.x - prevmouse.x, 2) + pow(mouse.y - prevmouse.y, 2) );
-// Mark that the mouse has been moved, in preparation for a new click. 
-if(speed > leeway) {
-  moving = int(speed); 
-  // If an autoclick timer was started and we're moving again, interrupt it.
-  clicktimer = 0;
-}
+// Auto-click engine compiled for the command line settings. Picked once at launch in WinMain().
+AutoClickFunction<WinIo> autoClicker = autoClick<GenericConfig, WinIo>;
 
-// DETECT SCROLLBAR MOUSEOVER:
-bool overscrollbar = false;
-static RECT scrollbararea = {};   
-// Set default location of window scrollbar:
-RECT windowframe = {};
-GetWindowRect(GetForegroundWindow(), &windowframe);
-RECT windowscrollarea = {windowframe.right - SCROLLBARWIDTH, windowframe.top + SCROLLBARTOP, windowframe.right, windowframe.bottom};   
-
-// Check if mouse is over a scrollbar area, and set scrollbar coordinates.
-// Because GetScrollBarInfo() doesn't work on Firefox, always check right edge of any program's window as well:
-if(PtInRect(&windowscrollarea, mouse)) {
-  overscrollbar = true; 
-  scrollbararea = windowscrollarea;
-}
-if(!overscrollbar) {
-  // Check sub-window scrollbars:
-  SCROLLBARINFO subscrollbar = {sizeof(SCROLLBARINFO)};   
-  GetScrollBarInfo(WindowFromPoint(mouse), OBJID_VSCROLL, &subscrollbar);   
-  // Check if mouse is over a sub-window scrollbar:
-  if(PtInRect(&subscrollbar.rcScrollBar, mouse)) {
-    overscrollbar = true; 
-    scrollbararea = subscrollbar.rcScrollBar;
-  }
-}
 
-// START SHIFT BUTTON DRAG:
-// Check if shift button is being held. 
-// shift + move should react instantly and even to minor movement in case of large documents' scrollbars.
-if(keyPressed(VK_SHIFT)) {
-  // Clear autoclick countdown while shift is pressed.
-  clicktimer = 0;
-  // Click-and-hold if mouse moves while shift is held.
-  if(!dragging && speed > 0) {
-    clickMouse(true);
-    dragging = true;
-  }
-}   
 
-// RELEASE SHIFT DRAG:
-// Instantly release mouse hold when shift key is released during shift-dragging.
-if(dragging && !keyPressed(VK_SHIFT)) {
-  clickMouse(false);
-  dragging = 0;
-  // Reset 'moving' or would de-click selected text.
-  moving = 0;
-  // Also wipe the countdown that was set when the mouse stopped moving,
-  // to not de-click immediately after dragging.
-  clicktimer = 0;
-  justclicked = TIMEBETWEENCLICKS;
-}
 
-// DETECT "PARKING" THE MOUSE:
-if(moving) {
-  // Block auto-clicking when moving mouse downward-right, 
-  // to allow the user to abort or "park" the mouse without clicking.
-  if(mouse.x >= prevmouse.x && mouse.y > prevmouse.y) {
-    parking = true;
-  }
-  if(parking) {
-    // Cancel parking when moving up
-    if(mouse.y < prevmouse.y
-    // or left
-    || mouse.x < prevmouse.x
-    // or straight horizontally right
-    || mouse.x > prevmouse.x + leeway && mouse.y <= prevmouse.y
-    // or when x distance is further than y distance, i.e. less than 45 degree angle.
-    || overscrollbar
-    ) {
-      parking = false;
-    }
-  }
-}
 
-// Block auto-click timer for a duration:
-if(justclicked) {
-  // Reduce timer to 0:
-  justclicked = max(0, justclicked - UPDATESPEED);
-  // Resetting 'moving' keeps from auto-clicking once time is up (after e.g. physical click)
-  moving = 0;
-}
+void recordMacro(unsigned char action, Point mouse, Rect windowframe) {
+/*
+  Appends an auto-click to the macro file while recording. Called just before the click is sent.
+  Positions are stored relative to 'windowframe', the foreground window before the click,
+  so that the macro still works when the window has moved, even if the click brings up another window.
+*/
+if(!macrofile) {return;}
+MacroStep step = {(unsigned int)(clockMs() - macrostart), short(mouse.x - windowframe.left), short(mouse.y - windowframe.top), action};
+fwrite(&step, sizeof(step), 1, macrofile);
+}   // End of function recordMacro()
+
 
-// START AUTO-CLICK TIMER WHEN MOUSE STOPS:
-// If the mouse was moving but coordinates are now the same, the mouse has stopped. 
-// Activate a countdown to click, but only if mouse speed was decreasing, to avoid accidental fast stops from clicking.
-if(moving && speed <= leeway && !physicalclick && !justclicked && !parking && !dragging) {
-  // Mouse no longer moves.
-  moving = 0;
-  // Immediately auto-click when mouse stops over scrollbar:
-  if(overscrollbar) {
-    // Set mouse coordinates in middle of scrollbar:
-    if(mouse.x > windowscrollarea.left && mouse.x <= windowscrollarea.right) {
-      SetCursorPos(windowscrollarea.left + 9, mouse.y);
-    }
-    // Release any mouse keys to RE-click WHENEVER mouse stops over scrollbar area
-    if(keyPressed(VK_LBUTTON) || keyPressed(VK_RBUTTON)) {
-      clickMouse(false);
-    }
-    // Momentarily press shift + click to automatically line up the scrollbar with the mouse cursor, wherever it is.
-    pressKey(VK_SHIFT, true);
-    clickMouse(true);
-    pressKey(VK_SHIFT, false);
-    scrolling = true;
-    clicktimer = 0;
-  }
-  // Set a long delay countdown when over the window close button or main program menu's, to prevent accidents:
-  else if(mouse.y >= windowframe.top && mouse.y <= windowframe.top + SCROLLBARTOP) {
-    clicktimer = MENUCLICKTIME;
-  }
-  // Normal countdown to auto-click:
-  else {clicktimer = CLICKTIME;}
-}
 
-// AUTO-CLICK AT END OF TIMER:
-if(clicktimer > 0 && !justclicked && !parking && !scrolling && !dragging) {
-  // Count down.
-  clicktimer -= UPDATESPEED;
-  // Click at end of timer. Optionally hold escape to override autoclicking temporarily.
-  if(clicktimer <= 0 && !keyPressed(VK_ESCAPE)) {
-    // Auto-click at end of countdown (press and release mouse button)
-    clickMouse(true);
-    clickMouse(false);
-    // After an auto-click, wait a minimum time before another auto-click.
-    justclicked = TIMEBETWEENCLICKS;
-    clicktimer = 0;
-    // Remember last auto-click location.
-    prevclick = mouse;                    
-  }   
-}
 
-// RELEASE SCROLLBAR: 
-if(scrolling) {
-  // If the mouse goes off the scrollbar and moves twice as far horizontally as vertically, release the scroll bar.
-  if(moving && !overscrollbar && abs(prevmouse.x - mouse.x) > 2*abs(prevmouse.y - mouse.y)
-  // Also release scrollbar when mouse moves too far away from it:
-  || abs(scrollbararea.left+7 - mouse.x) > SCROLLBARRANGE   // left and right maximum range
-  || mouse.y < scrollbararea.top
-  || mouse.y > scrollbararea.bottom
-  || physicalclick   
-  || keyPressed(VK_ESCAPE)
-  ) {
-    clickMouse(false);
-    scrolling = false;
-  }
-}
 
-// Store the current coordinates for the next movement check:
-GetCursorPos(&prevmouse);
-}   // End of function autoClick()
+void playMacro(double speed) {
+/*
+  Replays the recorded macro file, 'speed' times as fast as it was recorded. See replaySteps() in clickengine.h.
+*/
+struct MacroFile {
+  FILE *file;
+  bool read(MacroStep &step) {return fread(&step, sizeof(step), 1, file) == 1;}
+} macro = {fopen(MACROFILE, "rb")};
+if(!macro.file) {MessageBeep(MB_ICONSTOP);  return;}
+
+// Make Sleep(1) last about 1 millisecond rather than up to a 15.6 millisecond system timer tick.
+timeBeginPeriod(1);
+bool finished = replaySteps(macro, speed, settings.lefthanded, winio);
+timeEndPeriod(1);
+fclose(macro.file);
+MessageBeep((finished)? MB_OK : MB_ICONSTOP);
+}   // End of function playMacro()
+
+
+DWORD WINAPI replayMacro(LPVOID) {
+/*
+  Runs a macro replay on its own thread, so that the window keeps handling its messages meanwhile.
+*/
+playMacro(macrospeed);
+// Let autoClick() restart from the current coordinates, rather than click where the replay ended.
+clickstate.moving = 0;
+clickstate.prevmouse = winio.cursor();
+InterlockedExchange(&replaying, 0);
+return 0;
+}
 
 
 
@@ -267,7 +159,7 @@ time_t now = time(0);
 // Check how long the user has been working:
 const int activitykeys[] = {VK_SPACE, VK_RETURN, VK_LEFT, VK_UP, VK_RIGHT, VK_DOWN};
 for(unsigned k = 0; k < sizeof(activitykeys); k++) {
-  if(keyPressed(activitykeys[k])) {activity = true;  break;}
+  if(keyPressed(activitykeys[k])) {clickstate.activity = true;  break;}
 }
 
 // Log total worked time per day, at every minute tick, unless pausing. 
@@ -282,7 +174,7 @@ if(minutemark) {
 }
 
 // CHECK FOR END OF PAUSE:
-// endofpause is automatically postponed on activity.
+// endofpause is automatically postponed on clickstate.activity.
 if(now >= endofpause) {
   // Tell the user that pause has ended, but only if the user had overworked earlier. otherwise just reset 'worked' silently.
   if(workedtime >= MAXwork) {
@@ -302,32 +194,32 @@ if(now >= endofpause) {
   workedtime = 0;
   // Move the next pause, or would never reactivate.
   endofpause = now + MINpause * MINUTE;
-  activity = false;   
+  clickstate.activity = false;   
 }
 
 // SET PAUSE:
 // (Re-)set when the pause should end in UTC time.
-// Update whenever there is activity within a minute. 
-if(activity) {
+// Update whenever there is clickstate.activity within a minute. 
+if(clickstate.activity) {
   endofpause = now + max(MINpause, workedtime * MINpause/MAXwork) * MINUTE;
   fullpausetime = (endofpause - now);
 }
 
 // COUNT CURRENTLY WORKED TIME:
-// check for activity within every minute:
+// check for clickstate.activity within every minute:
 if(minutemark) {
-  if(activity || workedtime > 0) {workedtime += 1;}
-  // Prepare to remind to pause every 30 minutes (MAXwork), unless user is potentially pausing (no activity) in this minute:
+  if(clickstate.activity || workedtime > 0) {workedtime += 1;}
+  // Prepare to remind to pause every 30 minutes (MAXwork), unless user is potentially pausing (no clickstate.activity) in this minute:
   // Set lastwarned = 0 to activate reminder when user is still working and last-ignored reminder was at least 5 minutes ago.
-  if(activity && workedtime >= MAXwork && lastwarned <= now - 5*MINUTE) {lastwarned = 0;}
+  if(clickstate.activity && workedtime >= MAXwork && lastwarned <= now - 5*MINUTE) {lastwarned = 0;}
   // Reset for the next minute.
-  activity = false;
+  clickstate.activity = false;
 }
 
 // LAUNCH/POPUP RSI WARNING:
 // Do not immediately popup if user is currently busy holding mouse button or in the midst of typing. Minimum pause of a few seconds.
 // lastwarned is set to 0 when the warning should trigger.
-if(lastwarned == 0 && !physicalclick && !moving) {   
+if(lastwarned == 0 && !clickstate.physicalclick && !clickstate.moving) {   
   // Set length of pause in seconds.
   fullpausetime = int(endofpause - now);
   // Make the window visible on the screen. 
@@ -336,7 +228,7 @@ if(lastwarned == 0 && !physicalclick && !moving) {
   popup(hwnd);
   // Remember the last time we warned the user.
   lastwarned = now;
-  activity = false;   
+  clickstate.activity = false;   
 }
 return 0;
 }   // End of function remindToPause()
@@ -374,11 +266,24 @@ char *parameter = strtok(lpCmdLine, " ");
 while(parameter) {
   // Pass parameter "autoclick.exe left" to auto-click the right mouse button,
   // when mouse is set to left-handed in computer settings.
-  if(!stricmp(parameter, "left")) {lefthanded = true;} 
+  if(!stricmp(parameter, "left")) {settings.lefthanded = true;} 
+  // Pass "double" or "drag" to double-click or drag-lock when the mouse stops again where it last auto-clicked.
+  if(!stricmp(parameter, "double")) {settings.dwellmode = DWELL_DOUBLE;}
+  if(!stricmp(parameter, "drag")) {settings.dwellmode = DWELL_DRAG;}
+  // Pass "corner" to arm a one-shot right-click by stopping the mouse in the top-left screen corner.
+  if(!stricmp(parameter, "corner")) {settings.rightcorner = true;}
+  // Pass "noscroll" to not grab scrollbars, or "nopark" to also auto-click after moving down-right.
+  if(!stricmp(parameter, "noscroll")) {settings.scrollbars = false;}
+  if(!stricmp(parameter, "nopark")) {settings.parking = false;}
+  // Pass e.g. "speed=2" to replay macros twice as fast as they were recorded.
+  if(!strnicmp(parameter, "speed=", 6)) {macrospeed = max(0.1, atof(parameter + 6));}
   // Get the next parameter:
   parameter = strtok(NULL, " ");
 }
 
+// Pick the auto-click engine compiled for these settings:
+autoClicker = pickAutoClick<WinIo>(settings);
+
 // Display a donation message after 30 days:
 checkTrialTime(30);
 
@@ -486,6 +391,33 @@ case WM_TIMER: {
     break;
   }
 
+  // Hold scroll lock and press main key to start or stop recording auto-clicks as a macro:
+  if(!mainkeypressed && keyPressed(mainkey) && keyHeld(VK_SCROLL)) {
+    mainkeypressed = true;
+    if(macrofile) {
+      fclose(macrofile);
+      macrofile = NULL;
+      MessageBeep(MB_ICONSTOP);
+    }
+    else if((macrofile = fopen(MACROFILE, "wb"))) {
+      macrostart = clockMs();
+      MessageBeep(MB_ICONEXCLAMATION);
+    }
+  }
+
+  // Hold right control and press main key to replay the recorded macro:
+  if(!mainkeypressed && keyPressed(mainkey) && keyHeld(VK_RCONTROL)) {
+    mainkeypressed = true;
+    if(!replaying) {
+      // Let go of a drag-lock first, or the replay would drag instead of click.
+      releaseDragLock();
+      replaying = 1;
+      HANDLE thread = CreateThread(NULL, 0, replayMacro, NULL, 0, NULL);
+      if(thread) {CloseHandle(thread);}
+      else       {replaying = 0;}
+    }
+  }
+
   // Switch auto-clicking on or off (not yet at holding, for other function toggles):
   if(!mainkeypressed) {
     if(keyPressed(mainkey)
@@ -493,13 +425,15 @@ case WM_TIMER: {
     ) {
       mainkeypressed = true;
       autoClickON = !autoClickON;   // Toggle autoclick on/off
-      physicalclick = moving = 0;   
+      clickstate.physicalclick = clickstate.moving = 0;   
       // Change mouse cursor and tray icon:
       if(autoClickON) {
         MessageBeep(MB_ICONEXCLAMATION);
         SetSystemCursor(CopyCursor(autocursor), OCR_NORMAL);   
         trayicon.hIcon = trayiconON;
       } else {
+        // Let go of a drag-lock, as the auto-click engine won't run to release it.
+        releaseDragLock();
         MessageBeep(MB_ICONSTOP);
         SetSystemCursor(CopyCursor(normalcursor), OCR_NORMAL);
         trayicon.hIcon = trayiconOFF;
@@ -521,7 +455,8 @@ case WM_TIMER: {
   }
   
   // Run autoclicking functionality:
-  if(autoClickON) {autoClick(hwnd);}
+  // Don't auto-click while a macro replay moves the mouse.
+  if(autoClickON && !replaying) {autoClicker(clickstate, settings, winio);}
 
   // Count each minute:
   minutecounter += UPDATESPEED;
@@ -643,6 +578,9 @@ case WM_DESTROY: {
   // Inform user that program is deactivated.
   MessageBeep(MB_ICONSTOP);  
 
+  // Save any macro that was still being recorded.
+  if(macrofile) {fclose(macrofile);}
+
   // Failsafe: release any simulated keypresses that might be stuck:
   pressKey(VK_SHIFT, false);
   clickMouse(false);
@@ -686,6 +624,8 @@ if(GetModuleFileName(NULL, programfilename, MAX_PATH)) {
 
 // Checks if a particular key is held at the moment.
 bool keyPressed(unsigned char k) {return GetAsyncKeyState(k);}
+// Only true while the key is down, not when it was pressed at some point since the last check.
+bool keyHeld(unsigned char k) {return GetAsyncKeyState(k) & 0x8000;}
 
 
 void pressKey(const char key, bool down = true) {
@@ -700,17 +640,37 @@ Sleep(50);
 }
 
 
-void clickMouse(bool down = true) {
-// Simulate left mouse button down or up click.
-INPUT Input = {INPUT_MOUSE};
-if(lefthanded) {Input.mi.dwFlags = (down)? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;}
-else           {Input.mi.dwFlags = (down)? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;}
-SendInput(1, &Input, sizeof(INPUT));
+void sendMouse(const DWORD *flags, int count) {
+// Simulates a sequence of up to 4 mouse button events in one batch,
+// so that no other input can come inbetween, e.g. to keep a double-click together.
+INPUT Input[4] = {};
+for(int i = 0; i < count && i < 4; i++) {
+  Input[i].type = INPUT_MOUSE;
+  Input[i].mi.dwFlags = flags[i];
+}
+SendInput(min(count, 4), Input, sizeof(INPUT));
 // Give external programs a little time to process our simulated keypresses.
 Sleep(50);
 }
 
 
+void clickMouse(bool down = true) {
+// Simulate left mouse button down or up click, or right button when 'lefthanded'.
+const DWORD flag = (settings.lefthanded)? ((down)? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP)
+                                        : ((down)? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP);
+sendMouse(&flag, 1);
+}
+
+
+void releaseDragLock() {
+// Lets go of a mouse button held down by a drag-lock, and records it in a macro being recorded.
+if(!clickstate.draglocked) {return;}
+recordMacro(MACRO_UP, winio.cursor(), winio.foregroundFrame());
+clickMouse(false);
+clickstate.draglocked = false;
+}
+
+
 void popup(HWND window) {
 DWORD thisprogram = GetCurrentThreadId();
 DWORD frontprogram = GetWindowThreadProcessId(GetForegroundWindow(), NULL);
@@ -724,6 +684,16 @@ if(frontprogram != thisprogram) {
 }
 
 
+// Returns milliseconds on the high resolution clock, which is steady and unaffected by changes to the system time.
+double clockMs() {
+static LARGE_INTEGER frequency = {};
+if(!frequency.QuadPart) {QueryPerformanceFrequency(&frequency);}
+LARGE_INTEGER now = {};
+QueryPerformanceCounter(&now);
+return now.QuadPart * 1000.0 / frequency.QuadPart;
+}
+
+
 // This function is used to pad numbers 0 to 9 by returning a "0" to inject in a string.
 // e.g. sprintf(var, "%i:%s%i", 12, padwithzero(9), 9); prints the time "12:09"
 const char *padwithzero(int nr) {return (abs(nr) < 10)? "0" : "";}   
@@ -1,12 +1,18 @@
 // Main functions
 LRESULT CALLBACK WindowProcedure(HWND hwnd, UINT message, WPARAM wParam, LPARAM lParam);
-void autoClick(HWND hwnd);
+void recordMacro(unsigned char action, Point mouse, Rect windowframe);
+void playMacro(double speed);
+DWORD WINAPI replayMacro(LPVOID);
 int remindToPause(HWND hwnd, time_t &endofpause, bool minutemark);
 void checkTrialTime(int days);
 
 // Support functions
 bool keyPressed(unsigned char k);
+bool keyHeld(unsigned char k);
 void pressKey(const char key, bool down);
+void sendMouse(const DWORD *flags, int count);
 void clickMouse(bool down);
+void releaseDragLock();
 void popup(HWND window);
+double clockMs();
 const char *padwithzero(int nr);
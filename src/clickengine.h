@@ -0,0 +1,464 @@
+/*
+  The auto-click engine: decides from the mouse movement when to click, drag and grab scrollbars.
+  Also replays recorded click macros, with replaySteps().
+  It makes no Windows calls itself, so that the benchmarks in bench/ can drive it with recorded pointer traces and a fake clock.
+
+  autoClick() is a template over two policy types:
+  - Config supplies the settings. GenericConfig reads them from 'Settings' on every use,
+    FixedConfig<> makes them compile-time constants for the common configurations, so their branches compile away.
+  - Io reads the mouse and keyboard, sends the clicks, and is the clock source.
+    WinIo in autoclick.cpp uses the Windows API, the benchmark uses recorded traces and a timestamping sink.
+  An Io provides:
+    bool buttonHeld();                 whether the left or right mouse button is down.
+    bool shiftHeld();  bool escapeHeld();
+    Point cursor();  void setCursor(Point p);
+    Rect foregroundFrame();            outer frame of the foreground window.
+    Rect screenAt(Point p);            bounds of the monitor that 'p' is on.
+    bool subScrollbar(Point p, Rect &area);   whether 'p' is over a sub-window's vertical scrollbar.
+    double now();                      milliseconds on a steady clock.
+    void sleep(int ms);                waits at least 'ms' milliseconds, or yields the rest of the time slice when 0. Only for replaySteps().
+    double doubleClickTime();  Point doubleClickSize();
+    void sendMouse(const MouseEvent *events, int count);   sends the events in one batch.
+    void pressShift(bool down);  void beep();
+    void record(unsigned char action, Point p, Rect frame);   appends to a macro recording, if one is running.
+*/
+
+#ifndef CLICKENGINE_H
+#define CLICKENGINE_H
+
+#include <math.h>
+#include <stdlib.h>                   // for abs().
+
+
+const int UPDATESPEED = 50;           // Interval at which to update the mouse coordinates and speed. in milliseconds.
+
+// Dwell action modes, selected through command line parameter.
+// They decide what happens when the mouse stops a second time at the last auto-click location:
+const int DWELL_CLICK = 0;            // Just auto-click again.
+const int DWELL_DOUBLE = 1;           // Double-click, instead of pressing ENTER after an auto-click.
+const int DWELL_DRAG = 2;             // Hold the mouse button down until the next auto-click, instead of holding SHIFT.
+
+// Macro step actions:
+const unsigned char MACRO_CLICK = 1;        // Click once.
+const unsigned char MACRO_DOUBLECLICK = 2;  // Click twice in one batch.
+const unsigned char MACRO_OTHERCLICK = 3;   // Click once with the other mouse button, i.e. a right-click.
+const unsigned char MACRO_DOWN = 4;         // Press and hold the mouse button, to start a drag.
+const unsigned char MACRO_UP = 5;           // Release the mouse button, to end a drag.
+
+// One recorded auto-click, stored as is in the macro file. Packed to 9 bytes to keep files compact.
+#pragma pack(push, 1)
+struct MacroStep {
+  unsigned int time;                  // Milliseconds since start of recording.
+  short x, y;                         // Mouse position relative to the top-left corner of the foreground window.
+  unsigned char action;               // One of the MACRO_ actions.
+};
+#pragma pack(pop)
+
+// Mouse button events that the engine asks an Io to send:
+enum MouseEvent {LEFT_DOWN, LEFT_UP, RIGHT_DOWN, RIGHT_UP};
+
+struct Point {long x, y;};
+struct Rect {long left, top, right, bottom;};
+
+// Same as PtInRect(): the right and bottom edges are outside.
+inline bool inRect(const Rect &r, Point p) {return p.x >= r.left && p.x < r.right && p.y >= r.top && p.y < r.bottom;}
+// Whether 'p' is within 'size' pixels of the top-left corner of 'r', edges included.
+inline bool inCorner(const Rect &r, Point p, long size) {
+  return p.x >= r.left && p.x <= r.left + size && p.y >= r.top && p.y <= r.top + size;
+}
+
+
+// Settings, set through command line parameters:
+struct Settings {
+  bool lefthanded = false;            // auto-click the right button, when the mouse is configured for the left hand.
+  int dwellmode = DWELL_CLICK;        // one of the DWELL_ modes.
+  bool rightcorner = false;           // arm a one-shot right-click by dwelling in the top-left screen corner.
+  bool scrollbars = true;             // grab vertical scrollbars when the mouse stops over them.
+  bool parking = true;                // moving down-right "parks" the mouse without clicking.
+};
+
+// Generic configuration: reads every setting at runtime.
+struct GenericConfig {
+  static bool lefthanded(const Settings &s)  {return s.lefthanded;}
+  static int dwellmode(const Settings &s)    {return s.dwellmode;}
+  static bool rightcorner(const Settings &s) {return s.rightcorner;}
+  static bool scrollbars(const Settings &s)  {return s.scrollbars;}
+  static bool parking(const Settings &s)     {return s.parking;}
+};
+
+// Fixed configuration for the default settings, with either mouse button.
+template<bool LEFTHANDED> struct FixedConfig {
+  static bool lefthanded(const Settings &)  {return LEFTHANDED;}
+  static int dwellmode(const Settings &)    {return DWELL_CLICK;}
+  static bool rightcorner(const Settings &) {return false;}
+  static bool scrollbars(const Settings &)  {return true;}
+  static bool parking(const Settings &)     {return true;}
+};
+
+
+// Everything the engine remembers between ticks.
+struct ClickState {
+  // User activity tracking, also read by the pause reminders:
+  bool activity = true;               // Turned on when user clicks or types.
+  bool physicalclick = true;          // Set true if physical mouse button is pressed.
+                                      // Also set true at launch, as the user probably clicked to launch the program.
+  int moving = 0;                     // Speed of mouse in pixels per 50 milliseconds (i.e. per UPDATESPEED).
+  int totalclicks = 0;                // Count how many times a day user does mouseclicks.
+
+  // Variables for autoclicking:
+  Point prevmouse = {};               // previous mouse position, for calculating mouse speed.
+  Point prevclick = {};               // coordinates of last auto-click, for auto-selecting text.
+  int clicktimer = 0;                 // timer in microseconds. can be interrupted with further movement or right-click.
+  int justclicked = 0;                // timer in microseconds that temporarily blocks consequtive auto-clicks.
+  int parking = 0;                    // set when mouse is "parked"
+  int dragging = 0;                   // represents shift-click-drag
+  int draglocked = 0;                 // represents a mouse button held down by dwelling, in DWELL_DRAG mode.
+  int rightclickarmed = 0;            // set when the next auto-click should be a one-shot right-click.
+  double lastclicktime = 0;           // time of last auto-click in milliseconds, for double-click timing.
+  int lastclicks = 0;                 // number of clicks the last auto-click made. Only a plain single click (1) can be escalated
+                                      // by stopping there again, not a double-click, right-click, drag-lock or drop.
+  int scrolling = 0;
+  Rect scrollbararea = {};
+};
+
+
+template<class Config, class Io> void autoClick(ClickState &state, const Settings &settings, Io &io) {
+/*
+  Tracks mouse movement, speed, and scrollbar mouseover,
+  simulates a mouse click when mouse stops moving.
+  Called every UPDATESPEED milliseconds.
+*/
+
+// Configuration:
+const int SCROLLBARTOP = 60;          // pixels from top of window to top of scrollbar.
+const int SCROLLBARWIDTH = 27;        // standard scrollbar width in pixels.
+const int SCROLLBARRANGE = 100;       // distance between scrollbar and mouse x-coordinate beyond which the scrollbar is released.
+const int CLICKTIME = 200;            // delay between stop moving and auto-click, in milliseconds.
+const int MENUCLICKTIME = 500;        // delay between stop moving and auto-click when over window close buttons or menu bars.
+const int TIMEBETWEENCLICKS = 350;    // minimum time between two autoclicks, in milliseconds.
+const int leeway = 1;                 // ignorable accidental movement of mouse, in pixels.
+                                      // e.g. when removing hand from mouse, or wonky mouse.
+const int CORNERSIZE = 10;            // size in pixels of the top-left screen corner that arms a right-click.
+const int DWELLRANGE = 10;            // distance in pixels from the last auto-click within which stopping again counts as a second dwell.
+
+// Button mapping: which mouse button auto-clicks press, and which one the one-shot right-click presses.
+const bool lefthanded = Config::lefthanded(settings);
+const MouseEvent CLICK[4] = {(lefthanded)? RIGHT_DOWN : LEFT_DOWN, (lefthanded)? RIGHT_UP : LEFT_UP,
+                             (lefthanded)? RIGHT_DOWN : LEFT_DOWN, (lefthanded)? RIGHT_UP : LEFT_UP};
+const MouseEvent *DOWN = CLICK;       // press only.
+const MouseEvent *UP = CLICK + 1;     // release only.
+const MouseEvent OTHERCLICK[2] = {(lefthanded)? LEFT_DOWN : RIGHT_DOWN, (lefthanded)? LEFT_UP : RIGHT_UP};
+
+// Short names for the remembered state:
+bool &activity = state.activity;
+bool &physicalclick = state.physicalclick;
+int &moving = state.moving;
+Point &prevmouse = state.prevmouse;
+Point &prevclick = state.prevclick;
+int &clicktimer = state.clicktimer;
+int &justclicked = state.justclicked;
+int &parking = state.parking;
+int &dragging = state.dragging;
+int &draglocked = state.draglocked;
+int &rightclickarmed = state.rightclickarmed;
+int &scrolling = state.scrolling;
+Rect &scrollbararea = state.scrollbararea;
+
+// DETECT PHYSICAL CLICKS:
+// If the user is actually physically clicking a mouse button,
+// don't auto-click until they've released, and moved the mouse elsewhere.
+// Prevent and/or cancel any auto-click when mouse buttons are pressed down:
+if(io.buttonHeld()) {
+  if(!physicalclick && !justclicked && !dragging && !draglocked && !scrolling) {
+    physicalclick = true;
+    clicktimer = 0;
+  }
+  activity = true;
+}
+// On mouse release, restart at current coordinates.
+else if(physicalclick) {
+  state.totalclicks += 1;
+  physicalclick = false;
+  moving = 0;
+  // Set prevmouse position as if it was current position.
+  prevmouse = io.cursor();
+}
+
+// DETECT MOVEMENT AND SPEED:
+// Get current mouse screen coordinates,
+Point mouse = io.cursor();
+
+// then compare them with previous recorded mouse coordinates to calculate current mouse speed
+// (speed value is equal to pixels distance between previous x,y and current x,y)
+double speed = sqrt( pow(mouse.x - prevmouse.x, 2) + pow(mouse.y - prevmouse.y, 2) );
+// Mark that the mouse has been moved, in preparation for a new click.
+if(speed > leeway) {
+  moving = int(speed);
+  // If an autoclick timer was started and we're moving again, interrupt it.
+  clicktimer = 0;
+}
+
+// DETECT SCROLLBAR MOUSEOVER:
+bool overscrollbar = false;
+// Set default location of window scrollbar:
+Rect windowframe = io.foregroundFrame();
+Rect windowscrollarea = {windowframe.right - SCROLLBARWIDTH, windowframe.top + SCROLLBARTOP, windowframe.right, windowframe.bottom};
+
+if(Config::scrollbars(settings)) {
+  // Check if mouse is over a scrollbar area, and set scrollbar coordinates.
+  // Because GetScrollBarInfo() doesn't work on Firefox, always check right edge of any program's window as well:
+  if(inRect(windowscrollarea, mouse)) {
+    overscrollbar = true;
+    scrollbararea = windowscrollarea;
+  }
+  // Check sub-window scrollbars:
+  else if(io.subScrollbar(mouse, scrollbararea)) {
+    overscrollbar = true;
+  }
+}
+
+// START SHIFT BUTTON DRAG:
+// Check if shift button is being held.
+// shift + move should react instantly and even to minor movement in case of large documents' scrollbars.
+if(io.shiftHeld()) {
+  // Clear autoclick countdown while shift is pressed.
+  clicktimer = 0;
+  // Click-and-hold if mouse moves while shift is held.
+  if(!dragging && speed > 0) {
+    io.record(MACRO_DOWN, mouse, windowframe);
+    io.sendMouse(DOWN, 1);
+    dragging = true;
+  }
+}
+
+// RELEASE SHIFT DRAG:
+// Instantly release mouse hold when shift key is released during shift-dragging.
+if(dragging && !io.shiftHeld()) {
+  io.record(MACRO_UP, mouse, windowframe);
+  io.sendMouse(UP, 1);
+  dragging = 0;
+  // Reset 'moving' or would de-click selected text.
+  moving = 0;
+  // Also wipe the countdown that was set when the mouse stopped moving,
+  // to not de-click immediately after dragging.
+  clicktimer = 0;
+  justclicked = TIMEBETWEENCLICKS;
+}
+
+// DETECT "PARKING" THE MOUSE:
+if(moving && Config::parking(settings)) {
+  // Block auto-clicking when moving mouse downward-right,
+  // to allow the user to abort or "park" the mouse without clicking.
+  // Not while drag-locked, as dragging down-right must still be able to drop,
+  // nor while a right-click is armed in the top-left corner, from where every target lies down-right.
+  if(mouse.x >= prevmouse.x && mouse.y > prevmouse.y && !draglocked && !rightclickarmed) {
+    parking = true;
+  }
+  if(parking) {
+    // Cancel parking when moving up
+    if(mouse.y < prevmouse.y
+    // or left
+    || mouse.x < prevmouse.x
+    // or straight horizontally right
+    || mouse.x > prevmouse.x + leeway && mouse.y <= prevmouse.y
+    // or when x distance is further than y distance, i.e. less than 45 degree angle.
+    || overscrollbar
+    ) {
+      parking = false;
+    }
+  }
+}
+
+// Block auto-click timer for a duration:
+if(justclicked) {
+  // Reduce timer to 0:
+  justclicked = (justclicked > UPDATESPEED)? justclicked - UPDATESPEED : 0;
+  // Resetting 'moving' keeps from auto-clicking once time is up (after e.g. physical click)
+  moving = 0;
+}
+
+// START AUTO-CLICK TIMER WHEN MOUSE STOPS:
+// If the mouse was moving but coordinates are now the same, the mouse has stopped.
+// Activate a countdown to click, but only if mouse speed was decreasing, to avoid accidental fast stops from clicking.
+if(moving && speed <= leeway && !physicalclick && !justclicked && !parking && !dragging) {
+  // Mouse no longer moves.
+  moving = 0;
+  // Immediately auto-click when mouse stops over scrollbar, unless a drag-lock is holding the button:
+  if(overscrollbar && !draglocked) {
+    // Set mouse coordinates in middle of scrollbar:
+    if(mouse.x > windowscrollarea.left && mouse.x <= windowscrollarea.right) {
+      io.setCursor(Point{windowscrollarea.left + 9, mouse.y});
+    }
+    // Release any mouse keys to RE-click WHENEVER mouse stops over scrollbar area
+    if(io.buttonHeld()) {
+      io.sendMouse(UP, 1);
+    }
+    // Momentarily press shift + click to automatically line up the scrollbar with the mouse cursor, wherever it is.
+    io.pressShift(true);
+    io.sendMouse(DOWN, 1);
+    io.pressShift(false);
+    scrolling = true;
+    clicktimer = 0;
+  }
+  // Set a long delay countdown when over the window close button or main program menu's, to prevent accidents:
+  else if(mouse.y >= windowframe.top && mouse.y <= windowframe.top + SCROLLBARTOP) {
+    clicktimer = MENUCLICKTIME;
+  }
+  // Normal countdown to auto-click:
+  else {clicktimer = CLICKTIME;}
+}
+
+// AUTO-CLICK AT END OF TIMER:
+if(clicktimer > 0 && !justclicked && !parking && !scrolling && !dragging) {
+  // Count down.
+  clicktimer -= UPDATESPEED;
+  // Click at end of timer. Optionally hold escape to override autoclicking temporarily.
+  if(clicktimer <= 0 && !io.escapeHeld()) {
+    // Check whether the mouse stopped again near where it last auto-clicked a single click:
+    bool redwell = state.lastclicks == 1 && abs(mouse.x - prevclick.x) <= DWELLRANGE && abs(mouse.y - prevclick.y) <= DWELLRANGE;
+    int clicks = 0;
+    // Drop a drag-lock wherever the mouse stops next:
+    if(draglocked) {
+      io.record(MACRO_UP, mouse, windowframe);
+      io.sendMouse(UP, 1);
+      draglocked = false;
+    }
+    // Stopping in the top-left corner of a monitor arms a right-click for the next auto-click.
+    // Monitors left of or above the main one have negative coordinates, so test against the monitor's own corner:
+    else if(Config::rightcorner(settings) && inCorner(io.screenAt(mouse), mouse, CORNERSIZE)) {
+      rightclickarmed = true;
+      io.beep();
+    }
+    else if(rightclickarmed) {
+      io.record(MACRO_OTHERCLICK, mouse, windowframe);
+      io.sendMouse(OTHERCLICK, 2);
+      rightclickarmed = false;
+    }
+    // Escalate to a double-click when stopping again at the last auto-click location.
+    // If the last click is still within the system's double-click time and distance, one more click makes it a double-click.
+    // Stopping again takes at least TIMEBETWEENCLICKS + CLICKTIME, so that only happens with double-click times
+    // set longer than the default 500 milliseconds, as some users with RSI do.
+    else if(Config::dwellmode(settings) == DWELL_DOUBLE && redwell) {
+      Point doubleclicksize = io.doubleClickSize();
+      bool pairs = io.now() - state.lastclicktime < io.doubleClickTime()
+        && abs(mouse.x - prevclick.x) <= doubleclicksize.x/2
+        && abs(mouse.y - prevclick.y) <= doubleclicksize.y/2;
+      clicks = (pairs)? 1 : 2;
+      io.record((clicks == 2)? MACRO_DOUBLECLICK : MACRO_CLICK, mouse, windowframe);
+      io.sendMouse(CLICK, 2*clicks);
+      // Either way this completed a double-click, after which a single click would make a triple-click.
+      clicks = 2;
+    }
+    // Or lock the mouse button down to drag from there:
+    else if(Config::dwellmode(settings) == DWELL_DRAG && redwell) {
+      io.record(MACRO_DOWN, mouse, windowframe);
+      io.sendMouse(DOWN, 1);
+      draglocked = true;
+    }
+    else {
+      // Auto-click at end of countdown (press and release mouse button)
+      io.record(MACRO_CLICK, mouse, windowframe);
+      io.sendMouse(DOWN, 1);
+      io.sendMouse(UP, 1);
+      clicks = 1;
+    }
+    state.lastclicks = clicks;
+    state.lastclicktime = io.now();
+    // After an auto-click, wait a minimum time before another auto-click.
+    justclicked = TIMEBETWEENCLICKS;
+    clicktimer = 0;
+    // Remember last auto-click location.
+    prevclick = mouse;
+  }
+}
+
+// RELEASE SCROLLBAR:
+if(scrolling) {
+  // If the mouse goes off the scrollbar and moves twice as far horizontally as vertically, release the scroll bar.
+  if(moving && !overscrollbar && abs(prevmouse.x - mouse.x) > 2*abs(prevmouse.y - mouse.y)
+  // Also release scrollbar when mouse moves too far away from it:
+  || abs(scrollbararea.left+7 - mouse.x) > SCROLLBARRANGE   // left and right maximum range
+  || mouse.y < scrollbararea.top
+  || mouse.y > scrollbararea.bottom
+  || physicalclick
+  || io.escapeHeld()
+  ) {
+    io.sendMouse(UP, 1);
+    scrolling = false;
+  }
+}
+
+// RELEASE DRAG-LOCK:
+// Escape lets go of a mouse button held down by dwelling.
+if(draglocked && io.escapeHeld()) {
+  io.record(MACRO_UP, mouse, windowframe);
+  io.sendMouse(UP, 1);
+  draglocked = false;
+  justclicked = TIMEBETWEENCLICKS;
+}
+
+// Store the current coordinates for the next movement check:
+prevmouse = io.cursor();
+}   // End of function autoClick()
+
+
+// An auto-click engine compiled for one configuration and Io.
+template<class Io> using AutoClickFunction = void (*)(ClickState &state, const Settings &settings, Io &io);
+
+// Picks the engine compiled for the settings once at launch: a fixed configuration if one matches, otherwise the generic one.
+template<class Io> AutoClickFunction<Io> pickAutoClick(const Settings &settings) {
+const Settings defaults;
+if(settings.dwellmode == defaults.dwellmode && settings.rightcorner == defaults.rightcorner
+&& settings.scrollbars == defaults.scrollbars && settings.parking == defaults.parking) {
+  return (settings.lefthanded)? autoClick<FixedConfig<true>, Io> : autoClick<FixedConfig<false>, Io>;
+}
+return autoClick<GenericConfig, Io>;
+}
+
+
+
+template<class Io, class Steps> bool replaySteps(Steps &steps, double speed, bool lefthanded, Io &io) {
+/*
+  Replays macro steps 'speed' times as fast as they were recorded. 'steps.read(step)' returns false after the last step.
+  Each step waits for its deadline on the clock, so delays don't add up.
+  Stops immediately when the user moves the mouse or holds escape. Returns false if it stopped.
+*/
+const MouseEvent CLICK[4] = {(lefthanded)? RIGHT_DOWN : LEFT_DOWN, (lefthanded)? RIGHT_UP : LEFT_UP,
+                             (lefthanded)? RIGHT_DOWN : LEFT_DOWN, (lefthanded)? RIGHT_UP : LEFT_UP};
+const MouseEvent OTHERCLICK[2] = {(lefthanded)? LEFT_DOWN : RIGHT_DOWN, (lefthanded)? LEFT_UP : RIGHT_UP};
+bool held = false;                    // Whether a drag left the mouse button pressed down.
+bool aborted = false;
+Point expected = io.cursor();         // Where the cursor should be, unless the user moved it.
+const double start = io.now();
+MacroStep step = {};
+while(!aborted && steps.read(step)) {
+  const double deadline = start + step.time / speed;
+  // Wait for the deadline. Sleep 1 millisecond at a time while it is further off,
+  // and only yield the rest of the time slice during the last 2 milliseconds, in case sleeping 1 millisecond oversleeps.
+  while(true) {
+    Point mouse = io.cursor();
+    if(io.escapeHeld() || mouse.x != expected.x || mouse.y != expected.y) {aborted = true;  break;}
+    double remaining = deadline - io.now();
+    if(remaining <= 0) {break;}
+    io.sleep((remaining > 2)? 1 : 0);
+  }
+  if(aborted) {break;}
+
+  // Move to the recorded position in the current foreground window:
+  Rect windowframe = io.foregroundFrame();
+  io.setCursor(Point{windowframe.left + step.x, windowframe.top + step.y});
+  // Read back the position, as the system may have kept the cursor within the screen.
+  expected = io.cursor();
+
+  if(step.action == MACRO_CLICK)            {io.sendMouse(CLICK, 2);}
+  else if(step.action == MACRO_DOUBLECLICK) {io.sendMouse(CLICK, 4);}
+  else if(step.action == MACRO_OTHERCLICK)  {io.sendMouse(OTHERCLICK, 2);}
+  else if(step.action == MACRO_DOWN)        {io.sendMouse(CLICK, 1);  held = true;}
+  else if(step.action == MACRO_UP)          {io.sendMouse(CLICK + 1, 1);  held = false;}
+}
+// Don't leave the mouse button stuck when aborting halfway a drag.
+if(held) {io.sendMouse(CLICK + 1, 1);}
+return !aborted;
+}   // End of function replaySteps()
+
+#endif